@@ -0,0 +1,39 @@
+#!/bin/sh
+# Time `blame` on a file with a long history, cold and after one new commit
+# Usage: bench/blame.sh [revisions] [initial-lines]
+# Builds minigit from main.cpp unless MINIGIT points at a binary
+REVISIONS=${1:-10000}
+LINES=${2:-200}
+. "$(dirname "$0")/common.sh"
+
+# Linear history of one file: each revision edits, inserts or deletes a line
+python3 - "$REVISIONS" "$LINES" <<'PY'
+import random, sys
+revisions, count = map(int, sys.argv[1:])
+random.seed(3)
+lines = [f"line {i}" for i in range(count)]
+parent = ""
+for r in range(revisions):
+    op = random.random()
+    if op < 0.5:
+        lines[random.randrange(len(lines))] = f"edit {r}"
+    elif op < 0.8 or len(lines) <= 50:
+        lines.insert(random.randrange(len(lines) + 1), f"insert {r}")
+    else:
+        del lines[random.randrange(len(lines))]
+    blob = f"b{r:08x}"
+    open(f".minigit/objects/{blob}", "w").write("\n".join(lines) + "\n")
+    commit = f"c{r:08x}"
+    open(f".minigit/objects/{commit}", "w").write(
+        f"parent {parent}\ndate {1700000000 + r}\nmessage r{r}\nfile f {blob}\n")
+    parent = commit
+open(".minigit/branches", "w").write(f"master {parent}\n")
+open("f", "w").write("\n".join(lines) + "\n")
+PY
+
+echo "$REVISIONS revisions, $(wc -l < f) lines at HEAD"
+echo "blame, no cache:         $(timed "$MINIGIT" blame f)"
+echo "new commit" >> f
+"$MINIGIT" add f > /dev/null
+"$MINIGIT" commit -m "one more" > /dev/null
+echo "blame after new commit:  $(timed "$MINIGIT" blame f)"
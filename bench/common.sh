@@ -0,0 +1,32 @@
+# Shared setup for the benchmark scripts (sourced, not run directly)
+# Builds minigit from the current main.cpp into a scratch directory unless
+# MINIGIT points at a binary, creates an empty repository there and cd's
+# into it; everything is removed on exit
+set -e
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+SCRATCH=$(mktemp -d)
+MONITOR="" # Background fsmonitor to stop on exit, if any
+trap 'if [ -n "$MONITOR" ]; then kill "$MONITOR"; fi; rm -rf "$SCRATCH"' EXIT
+
+if [ -z "$MINIGIT" ]; then
+    MINIGIT=$SCRATCH/minigit
+    g++ -std=c++17 -O2 -pthread -o "$MINIGIT" "$ROOT/main.cpp"
+else
+    case $MINIGIT in
+        /*) ;;
+        *) MINIGIT=$(pwd)/$MINIGIT ;; # Still valid after the cd below
+    esac
+fi
+
+REPO=$SCRATCH/repo
+mkdir "$REPO"
+cd "$REPO"
+"$MINIGIT" init > /dev/null
+
+# Run a command and print how long it took
+timed() {
+    START=$(date +%s.%N)
+    "$@" > /dev/null
+    END=$(date +%s.%N)
+    echo "$(awk "BEGIN { print $END - $START }")s"
+}
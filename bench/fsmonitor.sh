@@ -0,0 +1,45 @@
+#!/bin/sh
+# Time `status` and `add -A` with and without the fsmonitor
+# Usage: bench/fsmonitor.sh [files] [changed-files]
+# Builds minigit from main.cpp unless MINIGIT points at a binary (Linux only)
+FILES=${1:-1000000}
+CHANGES=${2:-10}
+. "$(dirname "$0")/common.sh"
+
+# FILES small files, 1000 per directory, all committed
+python3 - "$FILES" <<'PY'
+import os, sys
+files = int(sys.argv[1])
+with open(".minigit/index", "w") as idx:
+    for i in range(files):
+        d = f"d{i // 1000}"
+        if i % 1000 == 0:
+            os.mkdir(d)
+        open(f"{d}/f{i}", "w").write(f"file {i}\n")
+        idx.write(f"{d}/f{i}\n")
+PY
+"$MINIGIT" commit -m base > /dev/null
+
+# Touch CHANGES files spread over the tree
+change() {
+    i=0
+    while [ $i -lt "$CHANGES" ]; do
+        n=$((i * FILES / CHANGES))
+        echo "change $1" >> "d$((n / 1000))/f$n"
+        i=$((i + 1))
+    done
+}
+
+echo "$FILES files, $CHANGES changed"
+change 1
+echo "status, full scan:       $(timed "$MINIGIT" status)"
+
+"$MINIGIT" fsmonitor > .minigit/fsmonitor.log &
+MONITOR=$!
+until grep -q watching .minigit/fsmonitor.log 2> /dev/null; do sleep 0.1; done
+"$MINIGIT" status > /dev/null # First query gets a token (full scan)
+
+change 2
+echo "status, fsmonitor:       $(timed "$MINIGIT" status)"
+change 3
+echo "add -A, fsmonitor:       $(timed "$MINIGIT" add -A)"
@@ -0,0 +1,39 @@
+#!/bin/sh
+# Time `gc` on a synthetic repository
+# Usage: bench/gc.sh [commits] [files-per-commit] [garbage-objects]
+# Builds minigit from main.cpp unless MINIGIT points at a binary
+COMMITS=${1:-20000}
+FILES=${2:-20}
+GARBAGE=${3:-50000}
+. "$(dirname "$0")/common.sh"
+
+# Two branches of linear history joined by a merge every 100 commits,
+# each commit changing one of FILES files; plus old unreachable blobs
+python3 - "$COMMITS" "$FILES" "$GARBAGE" <<'PY'
+import os, sys, time
+commits, files, garbage = map(int, sys.argv[1:])
+objs = ".minigit/objects"
+blobs = {}
+tips = {"master": "", "side": ""}
+for r in range(commits):
+    branch = "side" if r % 2 else "master"
+    f = r % files
+    blobs[f] = "b%08x" % r
+    open(f"{objs}/{blobs[f]}", "w").write(f"revision {r}\n")
+    head = f"parent {tips[branch]}\n"
+    if branch == "master" and r % 100 == 0 and tips["side"]:
+        head += f"parent2 {tips['side']}\n"
+    c = "c%08x" % r
+    entries = "".join(f"file f{i} {blobs.get(i, 'b00000000')}\n" for i in range(files))
+    open(f"{objs}/{c}", "w").write(f"{head}date {1700000000 + r}\nmessage r{r}\n{entries}")
+    tips[branch] = c
+old = time.time() - 30 * 86400
+for g in range(garbage):
+    path = f"{objs}/g{g:08x}"
+    open(path, "w").write(f"garbage {g}\n")
+    os.utime(path, (old, old))
+open(".minigit/branches", "w").write("".join(f"{b} {c}\n" for b, c in tips.items()))
+PY
+
+echo "gc: $COMMITS commits, $FILES files each, $GARBAGE unreachable objects"
+"$MINIGIT" gc
@@ -0,0 +1,39 @@
+#!/bin/sh
+# Time rename detection in `diff` on a commit that moves many files
+# Usage: bench/renames.sh [files] [lines-per-file]
+# Builds minigit from main.cpp unless MINIGIT points at a binary
+FILES=${1:-3000}
+LINES=${2:-40}
+. "$(dirname "$0")/common.sh"
+
+# Every file moves from old/ to new/; a third also get one line changed
+mkdir old new
+python3 - "$FILES" "$LINES" <<'PY'
+import sys
+files, lines = map(int, sys.argv[1:])
+with open(".minigit/index", "w") as idx:
+    for i in range(files):
+        open(f"old/f{i}", "w").write("".join(f"file {i} line {k}\n" for k in range(lines)))
+        idx.write(f"old/f{i}\n")
+PY
+"$MINIGIT" commit -m before > /dev/null
+BEFORE=$(cut -d' ' -f2 .minigit/branches)
+python3 - "$FILES" <<'PY'
+import os, sys
+files = int(sys.argv[1])
+with open(".minigit/index", "w") as idx:
+    for i in range(files):
+        os.rename(f"old/f{i}", f"new/f{i}")
+        if i % 3 == 0:
+            open(f"new/f{i}", "a").write("edited\n")
+        idx.write(f"old/f{i}\nnew/f{i}\n")
+PY
+"$MINIGIT" commit -m after > /dev/null
+AFTER=$(cut -d' ' -f2 .minigit/branches)
+
+for THRESHOLD in 50 30; do
+    START=$(date +%s.%N)
+    PAIRED=$("$MINIGIT" diff -M$THRESHOLD "$BEFORE" "$AFTER" | grep -c '^rename' || true)
+    END=$(date +%s.%N)
+    echo "diff -M$THRESHOLD: $PAIRED of $FILES moves paired in $(awk "BEGIN { print $END - $START }")s"
+done
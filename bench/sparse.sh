@@ -0,0 +1,33 @@
+#!/bin/sh
+# Compare checkout time and working tree size with and without sparse checkout
+# Usage: bench/sparse.sh [files] [directories]
+# Two of the directories are in the sparse checkout
+# Builds minigit from main.cpp unless MINIGIT points at a binary
+FILES=${1:-100000}
+DIRS=${2:-100}
+. "$(dirname "$0")/common.sh"
+
+# FILES files of about 300 bytes spread over DIRS directories, all committed
+python3 - "$FILES" "$DIRS" <<'PY'
+import os, sys
+files, dirs = map(int, sys.argv[1:])
+with open(".minigit/index", "w") as idx:
+    for d in range(dirs):
+        os.mkdir(f"d{d}")
+    for i in range(files):
+        path = f"d{i % dirs}/f{i}"
+        open(path, "w").write(f"file {i}\n" * 30)
+        idx.write(path + "\n")
+PY
+"$MINIGIT" commit -m base > /dev/null
+
+# Check out master into an empty working tree, report time and size
+checkout() {
+    rm -rf d*
+    echo "$1 $(timed "$MINIGIT" checkout master), $(du -sk --exclude=.minigit . | cut -f1) KB in working tree"
+}
+
+echo "$FILES files in $DIRS directories"
+checkout "full checkout:  "
+"$MINIGIT" sparse-checkout set d7 d42 > /dev/null
+checkout "sparse (d7 d42):"
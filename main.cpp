@@ -5,10 +5,30 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <ctime>
+#include <algorithm>
+#include <queue>
+#include <cmath>
+#include <cerrno>
+#include <cstring>
 #include <vector>
 #include <cstdio>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <utime.h>
 #include <sys/stat.h> // mkdir for Windows use <direct.h>
 
+// Linux inotify and local sockets for the filesystem monitor
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
 // Windows compatibility for directory creation
 #ifdef _WIN32
 #include <direct.h>
@@ -35,6 +55,12 @@ string hashToString(unsigned long h) {
     return oss.str();
 }
 
+// Check whether a path exists on disk
+bool fileExists(const string& path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0;
+}
+
 // Create directory if not exists
 void createDir(const string& dir) {
     struct stat info;
@@ -43,6 +69,28 @@ void createDir(const string& dir) {
     }
 }
 
+// Create the directories leading up to a file path
+void createParentDirs(const string& path) {
+    for (size_t pos = path.find('/'); pos != string::npos; pos = path.find('/', pos + 1)) {
+        createDir(path.substr(0, pos));
+    }
+}
+
+// Match a path against a glob pattern ('*' matches any run of characters,
+// '?' matches a single character)
+bool globMatch(const char* pattern, const char* path) {
+    if (*pattern == '\0') return *path == '\0';
+    if (*pattern == '*') {
+        for (const char* p = path; ; ++p) {
+            if (globMatch(pattern + 1, p)) return true;
+            if (*p == '\0') return false;
+        }
+    }
+    if (*path == '\0') return false;
+    if (*pattern != '?' && *pattern != *path) return false;
+    return globMatch(pattern + 1, path + 1);
+}
+
 // Read whole file content
 string readFile(const string& filename) {
     ifstream ifs(filename.c_str(), ios::binary);
@@ -58,6 +106,146 @@ void writeFile(const string& filename, const string& content) {
     ofs << content; // Write content to file
 }
 
+// Number of MinHash slots kept per file (split into bands for bucketing)
+const int SKETCH_SIZE = 32;
+
+// MinHash sketch of a file's set of line hashes
+// Files sharing many lines have many equal slots, so similarity can be
+// estimated without comparing full contents
+vector<unsigned long> minHashSketch(const string& content) {
+    vector<unsigned long> sketch(SKETCH_SIZE, ~0UL);
+    istringstream iss(content);
+    string line;
+    while (getline(iss, line)) {
+        unsigned long h = simpleHash(line);
+        for (int k = 0; k < SKETCH_SIZE; ++k) {
+            // Derive an independent hash per slot by remixing with the slot number
+            unsigned long x = h + 0x9e3779b97f4a7c15UL * (k + 1);
+            x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9UL;
+            x = (x ^ (x >> 27)) * 0x94d049bb133111ebUL;
+            x ^= x >> 31;
+            if (x < sketch[k]) sketch[k] = x;
+        }
+    }
+    return sketch;
+}
+
+// Estimated similarity (0-100) of two files from their sketches
+int sketchSimilarity(const vector<unsigned long>& a, const vector<unsigned long>& b) {
+    int same = 0;
+    for (int k = 0; k < SKETCH_SIZE; ++k) {
+        if (a[k] == b[k]) ++same;
+    }
+    return same * 100 / SKETCH_SIZE;
+}
+
+// Give every distinct line a small integer id so diffs compare ints
+vector<int> internLines(const string& content, unordered_map<string, int>& ids) {
+    vector<int> lines;
+    istringstream iss(content);
+    string line;
+    while (getline(iss, line)) {
+        lines.push_back(ids.emplace(line, (int)ids.size()).first->second);
+    }
+    return lines;
+}
+
+// Line diff (Myers' shortest edit script)
+// Returns, for each line of b, the matching line of a or -1 if b added it.
+// Common prefix and suffix are matched up front; if the middle needs more
+// than maxEdits edits it is treated as fully replaced to bound memory
+vector<int> matchLines(const vector<int>& a, const vector<int>& b, int maxEdits = 4096) {
+    vector<int> match(b.size(), -1);
+    int n = a.size(), m = b.size();
+    int pre = 0;
+    while (pre < n && pre < m && a[pre] == b[pre]) { match[pre] = pre; ++pre; }
+    int suf = 0;
+    while (suf < n - pre && suf < m - pre && a[n - 1 - suf] == b[m - 1 - suf]) {
+        match[m - 1 - suf] = n - 1 - suf;
+        ++suf;
+    }
+    n -= pre + suf;
+    m -= pre + suf;
+    if (n == 0 || m == 0) return match;
+
+    // Forward pass, keeping the furthest x reached on each diagonal k
+    // for every edit count d (only diagonals -d..d exist at step d)
+    int limit = min(n + m, maxEdits);
+    vector<vector<int>> trace;
+    vector<int> v(2 * limit + 3, 0);
+    int off = limit + 1;
+    bool done = false;
+    for (int d = 0; d <= limit && !done; ++d) {
+        for (int k = -d; k <= d; k += 2) {
+            int x = (k == -d || (k != d && v[off + k - 1] < v[off + k + 1])) ? v[off + k + 1] : v[off + k - 1] + 1;
+            int y = x - k;
+            while (x < n && y < m && a[pre + x] == b[pre + y]) { ++x; ++y; }
+            v[off + k] = x;
+            if (x >= n && y >= m) { done = true; break; }
+        }
+        trace.push_back(vector<int>(v.begin() + off - d, v.begin() + off + d + 1));
+    }
+    if (!done) return match; // Too different - middle counts as rewritten
+
+    // Walk the trace backwards collecting the diagonal (matching) runs
+    int x = n, y = m;
+    for (int d = (int)trace.size() - 1; d >= 0; --d) {
+        int k = x - y;
+        int prevK = k;
+        if (d > 0) {
+            const vector<int>& pv = trace[d - 1]; // Diagonals -(d-1)..(d-1)
+            auto at = [&](int kk) { return pv[kk + d - 1]; };
+            prevK = (k == -d || (k != d && at(k - 1) < at(k + 1))) ? k + 1 : k - 1;
+        }
+        int prevX = d > 0 ? trace[d - 1][prevK + d - 1] : 0;
+        int prevY = prevX - prevK;
+        while (x > prevX && y > prevY) {
+            --x; --y;
+            match[pre + y] = pre + x;
+        }
+        x = prevX;
+        y = prevY;
+    }
+    return match;
+}
+
+// Rows per band for a similarity threshold (%)
+// Uses the longest bands (fewest spurious candidates) with which a pair at
+// the threshold still shares at least one band 95% of the time: 1 row up to
+// 41%, 2 rows from 42% (including the default 50%), 4 rows from 75%
+int sketchRows(int threshold) {
+    double s = threshold / 100.0;
+    for (int rows = SKETCH_SIZE; rows > 1; rows /= 2) {
+        int bands = SKETCH_SIZE / rows;
+        if (1 - pow(1 - pow(s, rows), bands) >= 0.95) return rows;
+    }
+    return 1;
+}
+
+// Parse the value of a -M option: empty means the default, otherwise a
+// percentage from 1 to 100 (a trailing '%' is allowed)
+bool parseThreshold(string value, int& threshold) {
+    if (value.empty()) return true;
+    if (value.back() == '%') value.pop_back();
+    try {
+        size_t pos = 0;
+        int parsed = stoi(value, &pos);
+        if (pos != value.size() || parsed < 1 || parsed > 100) return false;
+        threshold = parsed;
+        return true;
+    } catch (const exception&) {
+        return false;
+    }
+}
+
+// A file that was moved (or copied) between two snapshots
+struct RenameMatch {
+    string from; // Path in the old snapshot
+    string to; // Path in the new snapshot
+    int score; // Similarity percentage
+    bool copy; // Source still exists in the new snapshot
+};
+
 // MiniGit class
 class MiniGit {
     // Repository directory strucutre
@@ -66,17 +254,34 @@ class MiniGit {
     string headFile = ".minigit/HEAD"; // Current branch reference
     string indexFile = ".minigit/index"; //Staging area tracking
     string branchesFile = ".minigit/branches"; //Branch pointers storage
+    string fsmonitorSocket = ".minigit/fsmonitor.sock"; // Filesystem monitor endpoint
+    string fsmonitorTokenFile = ".minigit/fsmonitor-token"; // Last token and still-dirty paths
+    string sparseFile = ".minigit/sparse-checkout"; // Sparse checkout patterns
+    string blameDir = ".minigit/blame"; // Cached line origins per (file, commit)
 
     // Data strucutre
     unordered_set<string> stagingArea; // Files staged for next commit
+    unordered_map<string, string> stagedBlobs; // Paths staged by blob id only (no working copy)
+    vector<string> sparsePatterns; // Paths to materialize (empty: everything)
     unordered_map<string, string> branches; // Maos branch names to commit hashes
     string head = "master"; // Current branch (deafult: master)
 
 public:
+    int renameThreshold = 50; // Minimum similarity (%) to pair a delete with an add
+
     // Public interface methods
     void merge(const string& otherBranch); // Merge anotherbranch into current
     void diff(const string& commit1, const string& commit2); // Show differences between commits
     string findLCA(const string& a, const string& b); // find lowest common ancestor commit
+    void gc(long long graceSeconds = 1209600); // Delete unreachable objects older than grace period
+    void fsmonitor(); // Watch the working tree and serve dirty paths
+    void status(); // Show staged, modified, deleted and untracked files
+    void addAll(bool includeUntracked = true); // Stage every change in the working tree
+    void sparseCheckout(const vector<string>& patterns, bool disable = false); // Set the sparse cone
+    void sparseList(); // Show sparse checkout patterns
+    void blame(const string& file); // Show the commit that last changed each line
+    vector<RenameMatch> detectRenames(const unordered_map<string, string>& oldFiles,
+                                      const unordered_map<string, string>& newFiles); // Pair moved/copied files
 
     // Initialize a new repository
     void init() {
@@ -101,7 +306,25 @@ public:
     // Add file to staging area
 
     void add(const string& filename) {
+        loadIndex(); // Keep files staged by earlier commands
         string content = readFile(filename);
+        if (content.empty() && !fileExists(filename)) {
+            // A tracked file that was deleted is staged as a removal
+            loadBranches();
+            head = readFile(headFile);
+            if (!head.empty()) head.erase(head.find_last_not_of(" \n\r\t")+1);
+            loadSparse();
+            if (!inSparseCone(filename)) {
+                cout << "Outside the sparse checkout, not removing: " << filename << "\n";
+                return;
+            }
+            if (branches.count(head) && loadCommitFiles(branches[head]).count(filename)) {
+                stagingArea.insert(filename);
+                saveIndex();
+                cout << "Staged removal of " << filename << "\n";
+                return;
+            }
+        }
         if (content.empty()) {
             cout << "File not found or empty: " << filename << "\n";
             return;
@@ -117,7 +340,7 @@ public:
         loadIndex(); // Load current staging area
 
         // Check if there are changes to commit
-        if (stagingArea.empty()) {
+        if (stagingArea.empty() && stagedBlobs.empty()) {
             cout << "No changes staged for commit.\n";
             return;
         }
@@ -144,16 +367,27 @@ public:
         unordered_set<string>::const_iterator it;
         for (it = stagingArea.begin(); it != stagingArea.end(); ++it) {
             const string& f = *it;
+            // A staged path missing from disk records a deletion
+            if (!fileExists(f)) {
+                files.erase(f);
+                continue;
+            }
             string content = readFile(f);
             string blobHash = hashToString(simpleHash(content)); // Generate content hash
             string blobPath = objectsDir + "/" + blobHash;
 
             // Store file content if not already in objects
-            if (readFile(blobPath).empty()) {
+            // An existing blob gets its mtime refreshed so gc's grace period
+            // protects it; if gc removed it meanwhile, write it again
+            if (!fileExists(blobPath) || utime(blobPath.c_str(), nullptr) != 0) {
                 writeFile(blobPath, content);
             }
             files[f] = blobHash; // Update file->hash mapping
         }
+        // Blob-only entries (sparse merges) are taken as-is, never read
+        for (const auto& pair : stagedBlobs) {
+            files[pair.first] = pair.second;
+        }
 
         // Create commit content
         ostringstream oss;
@@ -181,6 +415,7 @@ public:
         saveBranches();
         // Clear staging area
         stagingArea.clear();
+        stagedBlobs.clear();
         saveIndex();
 
         cout << "Committed to " << head << ": " << commitHash << "\n";
@@ -266,6 +501,14 @@ public:
     }
 
 private:
+    bool queryFsmonitor(const string& token, string& newToken, bool& fullScan,
+                        vector<string>& dirty); // Ask the monitor what changed since token
+    void collectChanges(vector<string>& modified, vector<string>& deleted,
+                        vector<string>& untracked); // Compare working tree against HEAD
+    void printFileDiff(const string& file1, const string& file2,
+                       const string& content1, const string& content2,
+                       const string& commit1, const string& commit2); // Print one file's diff
+
     // Save staging area to index file
     void saveIndex() {
         ofstream ofs(indexFile.c_str());
@@ -273,17 +516,48 @@ private:
         for (it = stagingArea.begin(); it != stagingArea.end(); ++it) {
             ofs << *it << "\n"; // Write each staged filename
         }
+        for (const auto& pair : stagedBlobs) {
+            ofs << pair.first << " " << pair.second << "\n"; // Format: filename blob_hash
+        }
     }
     
     // Load staging area from index file
     void loadIndex() {
         stagingArea.clear();
+        stagedBlobs.clear();
         ifstream ifs(indexFile.c_str());
         string line;
         while (getline(ifs, line)) {
-            if (!line.empty()) stagingArea.insert(line); // Add each filename
+            if (line.empty()) continue;
+            size_t pos = line.find(' ');
+            if (pos == string::npos) stagingArea.insert(line); // Add each filename
+            else stagedBlobs[line.substr(0, pos)] = line.substr(pos + 1);
+        }
+    }
+
+    // Load sparse checkout patterns (one per line)
+    void loadSparse() {
+        sparsePatterns.clear();
+        ifstream ifs(sparseFile.c_str());
+        string line;
+        while (getline(ifs, line)) {
+            if (!line.empty() && line[0] != '#') sparsePatterns.push_back(line);
         }
     }
+
+    // Check whether a path is inside the sparse checkout
+    // A pattern matches the path itself or any directory containing it
+    bool inSparseCone(const string& path) {
+        if (sparsePatterns.empty()) return true;
+        for (string pattern : sparsePatterns) {
+            if (pattern.size() > 1 && pattern.back() == '/') pattern.pop_back();
+            // Try the path itself, then each directory above it
+            for (size_t end = path.size(); end != string::npos && end > 0; end = path.rfind('/', end - 1)) {
+                if (globMatch(pattern.c_str(), path.substr(0, end).c_str())) return true;
+            }
+        }
+        return false;
+    }
     
     // Save branch information to file
     void saveBranches() {
@@ -347,12 +621,15 @@ private:
         // Get all files from commit
         unordered_map<string, string> files = loadCommitFiles(commitHash);
         unordered_map<string, string>::const_iterator it;
+        loadSparse();
 
         // Write each file to working directory
         for (it = files.begin(); it != files.end(); ++it) {
+            if (!inSparseCone(it->first)) continue; // Not materialized
             string blobPath = objectsDir + "/" + it->second;
             string content = readFile(blobPath);
             if (!content.empty()) {
+                createParentDirs(it->first);
                 writeFile(it->first, content);
             }
         }
@@ -373,10 +650,27 @@ int main(int argc, char* argv[]) {
     // Command routing
     if (cmd == "init") {
         mg.init();
+    } else if (cmd == "add" && argc == 3 && string(argv[2]) == "-A") {
+        mg.addAll();
     } else if (cmd == "add" && argc == 3) {
         mg.add(argv[2]);
     } else if (cmd == "commit" && argc == 4 && string(argv[2]) == "-m") {
         mg.commit(argv[3]);
+    } else if (cmd == "commit" && argc == 5 && string(argv[2]) == "-a" && string(argv[3]) == "-m") {
+        mg.addAll(false); // Stage tracked changes only
+        mg.commit(argv[4]);
+    } else if (cmd == "status") {
+        mg.status();
+    } else if (cmd == "fsmonitor") {
+        mg.fsmonitor();
+    } else if (cmd == "sparse-checkout" && argc >= 4 && string(argv[2]) == "set") {
+        mg.sparseCheckout(vector<string>(argv + 3, argv + argc));
+    } else if (cmd == "sparse-checkout" && argc == 3 && string(argv[2]) == "disable") {
+        mg.sparseCheckout(vector<string>(), true);
+    } else if (cmd == "sparse-checkout" && argc == 3 && string(argv[2]) == "list") {
+        mg.sparseList();
+    } else if (cmd == "blame" && argc == 3) {
+        mg.blame(argv[2]);
     } else if (cmd == "log") {
         mg.log();
     } else if (cmd == "branch" && argc == 3) {
@@ -385,10 +679,45 @@ int main(int argc, char* argv[]) {
         mg.checkout(argv[2]);
     } else if (cmd == "merge" && argc == 3) {
         mg.merge(argv[2]);
+    } else if (cmd == "merge" && argc == 4 && string(argv[2]).find("-M") == 0) {
+        // Rename similarity threshold
+        if (!parseThreshold(string(argv[2]).substr(2), mg.renameThreshold)) {
+            cout << "Invalid rename threshold: " << argv[2] << " (expected -M<1-100>)\n";
+            return 1;
+        }
+        mg.merge(argv[3]);
+    } else if (cmd == "gc" && argc == 2) {
+        mg.gc();
+    } else if (cmd == "gc" && argc == 3 && string(argv[2]).find("--prune=") == 0) {
+        // Grace period in seconds; anything that isn't a whole number is refused
+        string expire = string(argv[2]).substr(8);
+        long long seconds = -1;
+        size_t pos = 0;
+        try {
+            seconds = expire == "now" ? 0 : stoll(expire, &pos);
+            if (expire != "now" && pos != expire.size()) seconds = -1;
+        } catch (const exception&) {
+            seconds = -1;
+        }
+        if (seconds < 0) {
+            cout << "Usage: minigit gc [--prune=<seconds>|--prune=now]\n";
+            return 1;
+        }
+        mg.gc(seconds);
+    } else if (cmd == "prune" && argc == 2) {
+        mg.gc(0); // Prune every unreachable object immediately
     }
     else if (cmd == "diff" && argc == 4) {
         mg.diff(argv[2], argv[3]);
     }
+    else if (cmd == "diff" && argc == 5 && string(argv[2]).find("-M") == 0) {
+        // Rename similarity threshold
+        if (!parseThreshold(string(argv[2]).substr(2), mg.renameThreshold)) {
+            cout << "Invalid rename threshold: " << argv[2] << " (expected -M<1-100>)\n";
+            return 1;
+        }
+        mg.diff(argv[3], argv[4]);
+    }
     else {
         cout << "Unknown or incomplete command.\n";
     }
@@ -416,17 +745,82 @@ void MiniGit::merge(const string& otherBranch) {
     auto base = loadCommitFiles(baseCommit);
     auto ours = loadCommitFiles(ourCommit);
     auto theirs = loadCommitFiles(theirCommit);
+
+    bool hasConflicts = false; // Track if any conflicts occured
+
+    // Follow renames: a file moved on one side is merged under its new path,
+    // so edits made to the old path on the other side are not lost
+    unordered_map<string, string> ourMoves, theirMoves; // old path -> new path
+    for (const auto& r : detectRenames(base, ours)) if (!r.copy) ourMoves[r.from] = r.to;
+    for (const auto& r : detectRenames(base, theirs)) if (!r.copy) theirMoves[r.from] = r.to;
+    for (const auto& move : theirMoves) {
+        const string& from = move.first;
+        const string& to = move.second;
+        auto ourMove = ourMoves.find(from);
+        if (ourMove != ourMoves.end()) {
+            if (ourMove->second != to) {
+                // Both sides moved the file to different places
+                hasConflicts = true;
+                cout << "CONFLICT: " << from << " renamed to " << ourMove->second
+                     << " in HEAD and to " << to << " in " << otherBranch << "\n";
+                continue;
+            }
+            base[to] = base[from]; // Same move on both sides
+            base.erase(from);
+        } else if (ours.count(from) && !ours.count(to)) {
+            cout << "Following rename " << from << " -> " << to << "\n";
+            ours[to] = ours[from];
+            ours.erase(from);
+            base[to] = base[from];
+            base.erase(from);
+            remove(from.c_str()); // Old path leaves the working tree
+            loadIndex(); // Keep files staged by earlier commands
+            stagingArea.insert(from); // Staged as a deletion
+            saveIndex();
+        }
+    }
+    for (const auto& move : ourMoves) {
+        const string& from = move.first;
+        const string& to = move.second;
+        if (theirMoves.count(from)) continue; // Handled above
+        if (theirs.count(from) && !theirs.count(to)) {
+            cout << "Following rename " << from << " -> " << to << "\n";
+            theirs[to] = theirs[from];
+            theirs.erase(from);
+            base[to] = base[from];
+            base.erase(from);
+        }
+    }
     
     // Collect all files involved
     unordered_set<string> allFiles;
     for (const auto& pair : base) allFiles.insert(pair.first);
     for (const auto& pair : ours) allFiles.insert(pair.first);
     for (const auto& pair : theirs) allFiles.insert(pair.first);
-
-    bool hasConflicts = false; // Track if any conflicts occured
     
+    loadSparse();
+    unordered_map<string, string> sparseTaken; // Outside the cone: path -> their blob
+    vector<string> sparseRemoved; // Outside the cone: deleted by them
+
     // Three-way  merge for each file
     for (const auto& file : allFiles) {
+        // Outside the sparse checkout: resolve by blob id without touching
+        // the working tree; only real conflicts get written out
+        if (!inSparseCone(file)) {
+            string baseBlob = base.count(file) ? base[file] : "";
+            string ourBlob = ours.count(file) ? ours[file] : "";
+            string theirBlob = theirs.count(file) ? theirs[file] : "";
+            if (ourBlob == theirBlob || theirBlob == baseBlob) {
+                continue; // Keep ours
+            }
+            if (ourBlob == baseBlob) {
+                // Take theirs, staged once the loop is done
+                if (theirBlob.empty()) sparseRemoved.push_back(file);
+                else sparseTaken[file] = theirBlob;
+                continue;
+            }
+            cout << "CONFLICT: " << file << " is outside the sparse checkout, writing it out\n";
+        }
         // Get file content from all three versions
         string baseContent = base.count(file) ? readFile(objectsDir + "/" + base[file]) : "";
         string ourContent = ours.count(file) ? readFile(objectsDir + "/" + ours[file]) : "";
@@ -446,10 +840,12 @@ void MiniGit::merge(const string& otherBranch) {
                 string merged = "<<<<<<< HEAD (" + head + ")\n" + ourContent 
                                 + "\n=======\n" + theirContent 
                                 + "\n>>>>>>> " + otherBranch + "\n";
+                createParentDirs(file);
                 writeFile(file, merged);
             } 
             else if (!theirContent.empty()) {
                 // Only in theirs - take their version
+                createParentDirs(file);
                 writeFile(file, theirContent);
             }
         } 
@@ -457,10 +853,13 @@ void MiniGit::merge(const string& otherBranch) {
             remove(file.c_str()); // deleted in ours, unchanged in theirs
         } 
         else if (theirContent.empty() && baseContent == ourContent) {
-            continue; // deleted in theirs, unchanged in ours
+            // Deleted in theirs, unchanged in ours - delete it; the add below
+            // stages the missing path as a removal
+            remove(file.c_str());
         } 
         else if (baseContent == ourContent) {
             // We didn't change - take theirs
+            createParentDirs(file);
             writeFile(file, theirContent);
         } 
         else if (baseContent == theirContent) {
@@ -475,6 +874,7 @@ void MiniGit::merge(const string& otherBranch) {
             string merged = "<<<<<<< HEAD (" + head + ")\n" + ourContent 
                             + "\n=======\n" + theirContent 
                             + "\n>>>>>>> " + otherBranch + "\n";
+            createParentDirs(file);
             writeFile(file, merged);
         }
 
@@ -484,6 +884,15 @@ void MiniGit::merge(const string& otherBranch) {
             add(file);
         }
     }
+
+    // Stage the files resolved outside the sparse checkout in one pass;
+    // removals are paths missing from disk, which commit drops
+    if (!sparseTaken.empty() || !sparseRemoved.empty()) {
+        loadIndex();
+        for (const auto& pair : sparseTaken) stagedBlobs[pair.first] = pair.second;
+        stagingArea.insert(sparseRemoved.begin(), sparseRemoved.end());
+        saveIndex();
+    }
     
     // Handle merge result
 
@@ -552,6 +961,21 @@ void MiniGit::diff(const string& commit1, const string& commit2) {
     unordered_set<string> allFiles;
     for (const auto& pair : files1) allFiles.insert(pair.first);
     for (const auto& pair : files2) allFiles.insert(pair.first);
+
+    // Pair moved and copied files so they show as edits instead of delete + add
+    for (const auto& r : detectRenames(files1, files2)) {
+        cout << (r.copy ? "copy " : "rename ") << r.from << " => " << r.to
+             << " (" << r.score << "% similar)\n";
+        if (files1[r.from] != files2[r.to]) {
+            printFileDiff(r.from, r.to, readFile(objectsDir + "/" + files1[r.from]),
+                          readFile(objectsDir + "/" + files2[r.to]), commit1, commit2);
+        } else {
+            cout << "\n";
+        }
+        if (!r.copy) allFiles.erase(r.from);
+        allFiles.erase(r.to);
+    }
+
     // Compare each file
     for (const auto& file : allFiles) {
         // Get file content from both commits (empty if file exist)
@@ -560,26 +984,773 @@ void MiniGit::diff(const string& commit1, const string& commit2) {
         
         // Only show diff if files are different
         if (content1 != content2) {
-            // Show file headers with abbreviated commit hashes
-            cout << "--- " << file << " (" << commit1.substr(0,7) << ")\n";
-            cout << "+++ " << file << " (" << commit2.substr(0,7) << ")\n";
-            
-            // Line-by-line comparsion
-            istringstream iss1(content1);
-            istringstream iss2(content2);
-            string line1, line2;
-            int lineNum = 1;
-            
-            while (getline(iss1, line1) || getline(iss2, line2)) {
-                if (line1 != line2) {
-                    // Show line number and changes
-                    cout << "@@ -" << lineNum << " +" << lineNum << " @@\n";
-                    if (!line1.empty()) cout << "-" << line1 << "\n"; // Removed line
-                    if (!line2.empty()) cout << "+" << line2 << "\n"; // Added line
+            printFileDiff(file, file, content1, content2, commit1, commit2);
+        }
+    }
+}
+
+// Print a line-by-line diff of one file between two commits
+void MiniGit::printFileDiff(const string& file1, const string& file2,
+                            const string& content1, const string& content2,
+                            const string& commit1, const string& commit2) {
+    // Show file headers with abbreviated commit hashes
+    cout << "--- " << file1 << " (" << commit1.substr(0,7) << ")\n";
+    cout << "+++ " << file2 << " (" << commit2.substr(0,7) << ")\n";
+    
+    // Split both versions into lines and match them up
+    vector<string> lines1, lines2;
+    string line;
+    istringstream iss1(content1);
+    while (getline(iss1, line)) lines1.push_back(line);
+    istringstream iss2(content2);
+    while (getline(iss2, line)) lines2.push_back(line);
+    unordered_map<string, int> ids;
+    vector<int> match = matchLines(internLines(content1, ids), internLines(content2, ids));
+
+    // Each run of unmatched lines between two matched ones is one hunk
+    size_t i = 0, j = 0;
+    while (i < lines1.size() || j < lines2.size()) {
+        size_t end2 = j; // Next matched line of the new version
+        while (end2 < lines2.size() && match[end2] < 0) ++end2;
+        size_t end1 = end2 < lines2.size() ? (size_t)match[end2] : lines1.size();
+        if (i == end1 && j == end2) { // Unchanged line
+            ++i;
+            ++j;
+            continue;
+        }
+        // Show line numbers and changes
+        cout << "@@ -" << i + 1 << "," << end1 - i << " +" << j + 1 << "," << end2 - j << " @@\n";
+        for (; i < end1; ++i) cout << "-" << lines1[i] << "\n"; // Removed line
+        for (; j < end2; ++j) cout << "+" << lines2[j] << "\n"; // Added line
+    }
+    cout << "\n"; // Separate diffs with blank line
+}
+
+// Detect renames and copies between two snapshots (path -> blob maps)
+// Only paths that disappeared are rename sources; modified files may also be
+// copy sources. Candidates are found through MinHash band buckets, so the
+// full contents of unrelated files are never compared
+vector<RenameMatch> MiniGit::detectRenames(const unordered_map<string, string>& oldFiles,
+                                           const unordered_map<string, string>& newFiles) {
+    vector<RenameMatch> matches;
+    vector<string> added; // Paths only in the new snapshot
+    unordered_set<string> usedSources; // Deleted paths already paired as renames
+    unordered_map<string, string> blobToDeleted; // Exact-match lookup for deletions
+    unordered_map<string, string> blobToAny; // Exact-match lookup for copies
+
+    for (const auto& pair : oldFiles) {
+        if (!newFiles.count(pair.first)) blobToDeleted.emplace(pair.second, pair.first);
+        else blobToAny.emplace(pair.second, pair.first);
+    }
+    for (const auto& pair : newFiles) {
+        if (!oldFiles.count(pair.first)) added.push_back(pair.first);
+    }
+    if (added.empty()) return matches;
+
+    // Pass 1: identical blobs are renames (or copies) without reading anything
+    vector<string> pending;
+    for (const auto& path : added) {
+        const string& blob = newFiles.at(path);
+        auto del = blobToDeleted.find(blob);
+        if (del != blobToDeleted.end() && !usedSources.count(del->second)) {
+            usedSources.insert(del->second);
+            matches.push_back({del->second, path, 100, false});
+        } else if (blobToAny.count(blob)) {
+            matches.push_back({blobToAny[blob], path, 100, true});
+        } else {
+            pending.push_back(path);
+        }
+    }
+
+    // Remaining sources: unpaired deletions plus modified files
+    vector<string> sources;
+    for (const auto& pair : oldFiles) {
+        auto it = newFiles.find(pair.first);
+        if (it == newFiles.end() ? !usedSources.count(pair.first) : it->second != pair.second) {
+            sources.push_back(pair.first);
+        }
+    }
+    if (pending.empty() || sources.empty()) return matches;
+
+    // Pass 2: bucket source sketches by band; files sharing a band are candidates
+    // Lower thresholds use shorter bands so weaker matches still meet
+    const int rows = sketchRows(renameThreshold);
+    const int bands = SKETCH_SIZE / rows;
+    unordered_map<string, vector<unsigned long>> sketches;
+    unordered_map<string, vector<string>> buckets;
+    auto bandKey = [&](const vector<unsigned long>& sk, int band) {
+        ostringstream oss;
+        oss << band;
+        for (int r = 0; r < rows; ++r) oss << ' ' << sk[band * rows + r];
+        return oss.str();
+    };
+    for (const auto& path : sources) {
+        sketches[path] = minHashSketch(readFile(objectsDir + "/" + oldFiles.at(path)));
+        for (int band = 0; band < bands; ++band) {
+            buckets[bandKey(sketches[path], band)].push_back(path);
+        }
+    }
+
+    // Score every candidate pair that clears the threshold
+    vector<RenameMatch> candidates;
+    for (const auto& path : pending) {
+        vector<unsigned long> sk = minHashSketch(readFile(objectsDir + "/" + newFiles.at(path)));
+        unordered_set<string> seen;
+        for (int band = 0; band < bands; ++band) {
+            auto bucket = buckets.find(bandKey(sk, band));
+            if (bucket == buckets.end()) continue;
+            for (const auto& src : bucket->second) {
+                if (!seen.insert(src).second) continue;
+                int score = sketchSimilarity(sketches[src], sk);
+                if (score >= renameThreshold) {
+                    candidates.push_back({src, path, score, newFiles.count(src) > 0});
+                }
+            }
+        }
+    }
+
+    // Best pairs first; each deleted path is renamed at most once and any
+    // extra destinations become copies of it
+    stable_sort(candidates.begin(), candidates.end(),
+                [](const RenameMatch& x, const RenameMatch& y) { return x.score > y.score; });
+    unordered_set<string> pairedTargets;
+    for (auto c : candidates) {
+        if (pairedTargets.count(c.to)) continue;
+        if (!c.copy && usedSources.count(c.from)) c.copy = true;
+        if (!c.copy) usedSources.insert(c.from);
+        pairedTargets.insert(c.to);
+        matches.push_back(c);
+    }
+    return matches;
+}
+
+// Garbage collect unreachable objects
+// Marks everything reachable from the branch pointers, then deletes the rest
+void MiniGit::gc(long long graceSeconds) {
+    auto start = chrono::steady_clock::now();
+    loadBranches();
+
+    // Reachable object set, seeded with every branch tip
+    unordered_set<string> reachable;
+    vector<string> frontier; // Commits discovered but not yet parsed
+    for (const auto& pair : branches) {
+        if (!pair.second.empty() && reachable.insert(pair.second).second) {
+            frontier.push_back(pair.second);
+        }
+    }
+
+    // Blobs staged by id for the next commit are live too
+    loadIndex();
+    for (const auto& pair : stagedBlobs) reachable.insert(pair.second);
+
+    // Only commits are parsed - blobs are leaves, and their content may
+    // contain lines that look like "parent" or "file" entries
+    unsigned workers = thread::hardware_concurrency();
+    if (workers == 0) workers = 4;
+
+    // One pool of workers shares the frontier: each takes a commit, reads it
+    // outside the lock and queues newly discovered parents for any worker
+    mutex lock;
+    condition_variable wake;
+    size_t busy = 0; // Workers currently reading a commit
+    auto work = [&]() {
+        unique_lock<mutex> guard(lock);
+        while (true) {
+            wake.wait(guard, [&]() { return !frontier.empty() || busy == 0; });
+            if (frontier.empty()) break; // Nothing queued and nobody can add more
+            string commit = frontier.back();
+            frontier.pop_back();
+            ++busy;
+            guard.unlock();
+
+            vector<string> parents, blobs;
+            istringstream iss(readFile(objectsDir + "/" + commit));
+            string line;
+            while (getline(iss, line)) {
+                if (line.find("parent ") == 0 && line.size() > 7) {
+                    parents.push_back(line.substr(7));
+                } else if (line.find("parent2 ") == 0 && line.size() > 8) {
+                    parents.push_back(line.substr(8));
+                } else if (line.find("file ") == 0) {
+                    size_t pos = line.find(' ', 5);
+                    if (pos != string::npos) blobs.push_back(line.substr(pos + 1));
                 }
-                lineNum++;
             }
-            cout << "\n"; // Separate diffs with blank line
+
+            guard.lock();
+            for (const auto& b : blobs) reachable.insert(b);
+            for (const auto& p : parents) {
+                if (reachable.insert(p).second) frontier.push_back(p);
+            }
+            --busy;
+            wake.notify_all();
+        }
+        wake.notify_all(); // Let the other workers see the traversal is done
+    };
+    vector<thread> pool;
+    for (unsigned w = 0; w < workers; ++w) pool.emplace_back(work);
+    for (auto& t : pool) t.join();
+
+    // Sweep: remove unreachable objects older than the grace period
+    // Fresh objects are kept so an in-progress commit is never pruned
+    time_t cutoff = time(nullptr) - graceSeconds;
+    size_t scanned = 0, reclaimed = 0;
+    unsigned long long bytes = 0;
+    error_code ec;
+    for (filesystem::directory_iterator it(objectsDir, ec), end; !ec && it != end; it.increment(ec)) {
+        string name = it->path().filename().string();
+        ++scanned;
+        if (reachable.count(name)) continue;
+
+        struct stat info;
+        string path = it->path().string();
+        if (stat(path.c_str(), &info) != 0 || info.st_mtime > cutoff) continue;
+        if (remove(path.c_str()) == 0) {
+            ++reclaimed;
+            bytes += info.st_size;
         }
     }
-}
\ No newline at end of file
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "Scanned " << scanned << " objects, " << reachable.size() << " reachable\n";
+    cout << "Pruned " << reclaimed << " objects (" << bytes << " bytes)\n";
+    cout << "gc took " << seconds << "s\n";
+}
+
+// Run the filesystem monitor in the foreground
+// Every change inotify reports under the working tree is recorded with a
+// sequence number; clients send the token from their last query and get
+// back the paths changed since then
+void MiniGit::fsmonitor() {
+#ifdef __linux__
+    int ifd = inotify_init1(IN_NONBLOCK);
+    if (ifd < 0) {
+        cout << "Could not start inotify\n";
+        return;
+    }
+    const uint32_t mask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB
+                        | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_ONLYDIR;
+
+    unordered_map<int, string> watches; // Watch descriptor -> directory ("" is the root)
+    unordered_map<string, unsigned long long> dirty; // Path -> sequence of last change
+    unsigned long long seq = 0; // Advances with every recorded change
+    unsigned long long overflowSeq = 0; // Tokens older than this need a full scan
+    bool unwatched = false; // Some directory couldn't be watched - always answer "full"
+    const size_t maxDirty = 1 << 20; // More distinct dirty paths than this: reset as on overflow
+
+    // Record a change; past the cap, forget everything and make clients rescan
+    auto record = [&](const string& path) {
+        dirty[path] = ++seq;
+        if (dirty.size() > maxDirty) {
+            overflowSeq = ++seq;
+            dirty.clear();
+        }
+    };
+
+    // Watch a directory and everything below it, marking its files dirty
+    // (files created before the watch was added would otherwise be missed)
+    auto watchTree = [&](const string& dir) {
+        vector<string> stack(1, dir);
+        while (!stack.empty()) {
+            string d = stack.back();
+            stack.pop_back();
+            int wd = inotify_add_watch(ifd, d.empty() ? "." : d.c_str(), mask);
+            if (wd >= 0) {
+                watches[wd] = d;
+            } else if (errno != ENOENT && !unwatched) {
+                // Changes below this directory would be missed (usually
+                // fs.inotify.max_user_watches is exhausted)
+                unwatched = true;
+                cout << "Could not watch " << (d.empty() ? "." : d) << ": " << strerror(errno)
+                     << "; clients will fall back to full scans" << endl;
+            }
+            error_code ec;
+            for (filesystem::directory_iterator it(d.empty() ? "." : d, ec), end; !ec && it != end; it.increment(ec)) {
+                string name = it->path().filename().string();
+                if (d.empty() && name == ".minigit") continue; // Repository metadata
+                string path = d.empty() ? name : d + "/" + name;
+                if (it->is_directory(ec) && !it->is_symlink(ec)) stack.push_back(path);
+                else if (!dir.empty()) record(path);
+            }
+        }
+    };
+    watchTree("");
+
+    // Local socket clients connect to
+    int lfd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    fsmonitorSocket.copy(addr.sun_path, sizeof(addr.sun_path) - 1);
+    unlink(fsmonitorSocket.c_str()); // Left behind by an earlier run
+    if (lfd < 0 || bind(lfd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(lfd, 16) != 0) {
+        cout << "Could not listen on " << fsmonitorSocket << "\n";
+        close(ifd);
+        return;
+    }
+
+    // Tokens from a previous monitor process can't be trusted
+    string instance = hashToString(simpleHash(to_string(getpid()) + " " + to_string(time(nullptr))));
+    cout << "fsmonitor watching " << watches.size() << " directories" << endl;
+
+    vector<char> buf(64 * 1024);
+    pollfd fds[2] = {{ifd, POLLIN, 0}, {lfd, POLLIN, 0}};
+    while (poll(fds, 2, -1) >= 0) {
+        // Record inotify events
+        if (fds[0].revents & POLLIN) {
+            ssize_t len;
+            while ((len = read(ifd, buf.data(), buf.size())) > 0) {
+                for (char* p = buf.data(); p < buf.data() + len;) {
+                    inotify_event* ev = (inotify_event*)p;
+                    p += sizeof(inotify_event) + ev->len;
+                    if (ev->mask & IN_Q_OVERFLOW) {
+                        // Events were dropped - everyone has to rescan
+                        overflowSeq = ++seq;
+                        dirty.clear();
+                        continue;
+                    }
+                    if (ev->mask & IN_IGNORED) {
+                        watches.erase(ev->wd);
+                        continue;
+                    }
+                    auto w = watches.find(ev->wd);
+                    if (w == watches.end() || ev->len == 0) continue;
+                    string name = ev->name;
+                    if (w->second.empty() && name == ".minigit") continue;
+                    string path = w->second.empty() ? name : w->second + "/" + name;
+                    record(path);
+                    if ((ev->mask & IN_ISDIR) && (ev->mask & (IN_CREATE | IN_MOVED_TO))) {
+                        watchTree(path); // New directory - watch it too
+                    }
+                }
+            }
+        }
+
+        // Answer a client: "<token>" -> "<new token>", "ok" or "full", then paths
+        if (fds[1].revents & POLLIN) {
+            int cfd = accept(lfd, nullptr, nullptr);
+            if (cfd < 0) continue;
+            string request;
+            char c;
+            while (read(cfd, &c, 1) == 1 && c != '\n') request += c;
+
+            unsigned long long since = 0;
+            bool known = false;
+            size_t colon = request.find(':');
+            if (colon != string::npos && request.substr(0, colon) == instance && !unwatched) {
+                // A malformed token just gets the full-scan answer
+                string number = request.substr(colon + 1);
+                try {
+                    size_t pos = 0;
+                    since = stoull(number, &pos);
+                    known = pos == number.size() && number[0] != '-' && since >= overflowSeq && since <= seq;
+                } catch (const exception&) {
+                    known = false;
+                }
+            }
+            ostringstream reply;
+            reply << instance << ":" << seq << "\n" << (known ? "ok" : "full") << "\n";
+            if (known) {
+                // The client replaces its token with the new one, so changes up
+                // to the token it sent are no longer needed; older tokens will
+                // get the full-scan answer
+                for (auto it = dirty.begin(); it != dirty.end();) {
+                    if (it->second > since) {
+                        reply << it->first << "\n";
+                        ++it;
+                    } else {
+                        it = dirty.erase(it);
+                    }
+                }
+                overflowSeq = max(overflowSeq, since);
+            }
+            string out = reply.str();
+            for (size_t sent = 0; sent < out.size();) {
+                ssize_t n = write(cfd, out.data() + sent, out.size() - sent);
+                if (n <= 0) break;
+                sent += n;
+            }
+            close(cfd);
+        }
+    }
+    close(lfd);
+    close(ifd);
+#else
+    cout << "fsmonitor requires Linux inotify\n";
+#endif
+}
+
+// Ask a running fsmonitor for paths changed since token
+// Returns false when no monitor is running
+bool MiniGit::queryFsmonitor(const string& token, string& newToken, bool& fullScan,
+                             vector<string>& dirty) {
+#ifdef __linux__
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    fsmonitorSocket.copy(addr.sun_path, sizeof(addr.sun_path) - 1);
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return false;
+    }
+    string request = token + "\n";
+    if (write(fd, request.data(), request.size()) != (ssize_t)request.size()) {
+        close(fd);
+        return false;
+    }
+
+    // Read the whole reply
+    string response;
+    char buf[4096];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) response.append(buf, n);
+    close(fd);
+
+    istringstream iss(response);
+    string status, line;
+    if (!getline(iss, newToken) || !getline(iss, status)) return false;
+    fullScan = status != "ok";
+    while (getline(iss, line)) {
+        if (!line.empty()) dirty.push_back(line);
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Compare the working tree against the HEAD commit
+// With a running fsmonitor only paths changed since the last check (plus
+// those that were still dirty then) are read; otherwise every file is
+void MiniGit::collectChanges(vector<string>& modified, vector<string>& deleted,
+                             vector<string>& untracked) {
+    loadBranches();
+    head = readFile(headFile);
+    if (!head.empty()) head.erase(head.find_last_not_of(" \n\r\t")+1);
+    string current = branches.count(head) ? branches[head] : "";
+    unordered_map<string, string> tracked = loadCommitFiles(current);
+
+    // Saved state: token, commit it was checked against, still-dirty paths
+    istringstream saved(readFile(fsmonitorTokenFile));
+    string oldToken, oldCommit, line;
+    getline(saved, oldToken);
+    getline(saved, oldCommit);
+
+    string newToken;
+    bool fullScan = true;
+    vector<string> dirty;
+    bool monitored = queryFsmonitor(oldToken, newToken, fullScan, dirty);
+
+    unordered_set<string> candidates;
+    if (monitored && !fullScan) {
+        while (getline(saved, line)) {
+            if (!line.empty()) candidates.insert(line);
+        }
+        candidates.insert(dirty.begin(), dirty.end());
+        // HEAD moved without touching files (commit, branch switch):
+        // paths whose blob differs between the two commits need a look
+        if (oldCommit != current) {
+            unordered_map<string, string> previous = loadCommitFiles(oldCommit);
+            for (const auto& pair : previous) {
+                auto it = tracked.find(pair.first);
+                if (it == tracked.end() || it->second != pair.second) candidates.insert(pair.first);
+            }
+            for (const auto& pair : tracked) {
+                if (!previous.count(pair.first)) candidates.insert(pair.first);
+            }
+        }
+        // A removed or renamed directory only reports its own name
+        for (const auto& path : dirty) {
+            if (tracked.count(path) || fileExists(path)) continue;
+            string prefix = path + "/";
+            for (const auto& pair : tracked) {
+                if (pair.first.compare(0, prefix.size(), prefix) == 0) candidates.insert(pair.first);
+            }
+        }
+    } else {
+        // Full scan: every tracked path and every file on disk
+        for (const auto& pair : tracked) candidates.insert(pair.first);
+        error_code ec;
+        filesystem::recursive_directory_iterator it(".", ec), end;
+        for (; !ec && it != end; it.increment(ec)) {
+            string path = it->path().generic_string().substr(2); // Strip "./"
+            if (path == ".minigit") {
+                it.disable_recursion_pending();
+                continue;
+            }
+            if (it->is_regular_file(ec)) candidates.insert(path);
+        }
+    }
+
+    // Read only the candidates
+    loadSparse();
+    for (const auto& path : candidates) {
+        struct stat info;
+        bool isFile = stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode);
+        auto it = tracked.find(path);
+        if (it != tracked.end()) {
+            if (!isFile && !inSparseCone(path)) continue; // Absent by design
+            if (!isFile) deleted.push_back(path);
+            else if (hashToString(simpleHash(readFile(path))) != it->second) modified.push_back(path);
+        } else if (isFile && path.find(".minigit/") != 0) {
+            untracked.push_back(path);
+        }
+    }
+    sort(modified.begin(), modified.end());
+    sort(deleted.begin(), deleted.end());
+    sort(untracked.begin(), untracked.end());
+
+    // Remember what is still dirty so the next query can start from here
+    if (monitored) {
+        ostringstream oss;
+        oss << newToken << "\n" << current << "\n";
+        for (const auto& path : modified) oss << path << "\n";
+        for (const auto& path : deleted) oss << path << "\n";
+        for (const auto& path : untracked) oss << path << "\n";
+        writeFile(fsmonitorTokenFile, oss.str());
+    }
+}
+
+// Show the state of the working tree
+void MiniGit::status() {
+    vector<string> modified, deleted, untracked;
+    collectChanges(modified, deleted, untracked);
+    loadIndex();
+
+    cout << "On branch " << head << "\n";
+    if (!stagingArea.empty() || !stagedBlobs.empty()) {
+        vector<string> staged(stagingArea.begin(), stagingArea.end());
+        for (const auto& pair : stagedBlobs) staged.push_back(pair.first);
+        sort(staged.begin(), staged.end());
+        cout << "Changes to be committed:\n";
+        for (const auto& f : staged) cout << "  " << f << "\n";
+    }
+    if (!modified.empty() || !deleted.empty()) {
+        cout << "Changes not staged for commit:\n";
+        for (const auto& f : modified) cout << "  modified: " << f << "\n";
+        for (const auto& f : deleted) cout << "  deleted:  " << f << "\n";
+    }
+    if (!untracked.empty()) {
+        cout << "Untracked files:\n";
+        for (const auto& f : untracked) cout << "  " << f << "\n";
+    }
+    if (stagingArea.empty() && stagedBlobs.empty() && modified.empty() && deleted.empty() && untracked.empty()) {
+        cout << "Nothing to commit, working tree clean\n";
+    }
+}
+
+// Stage all modified and deleted files (and new files unless disabled)
+void MiniGit::addAll(bool includeUntracked) {
+    vector<string> modified, deleted, untracked;
+    collectChanges(modified, deleted, untracked);
+    loadIndex();
+
+    stagingArea.insert(modified.begin(), modified.end());
+    stagingArea.insert(deleted.begin(), deleted.end()); // Staged as removals
+    size_t added = 0;
+    if (includeUntracked) {
+        for (const auto& f : untracked) {
+            if (readFile(f).empty()) continue; // Empty files can't be added
+            stagingArea.insert(f);
+            ++added;
+        }
+    }
+    saveIndex();
+    cout << "Staged " << modified.size() << " modified, " << deleted.size() << " deleted, "
+         << added << " new files\n";
+}
+
+// Restrict the working tree to paths matching the given patterns
+// Files leaving the cone are removed (unless they have local changes) and
+// files entering it are written from the HEAD commit
+void MiniGit::sparseCheckout(const vector<string>& patterns, bool disable) {
+    auto start = chrono::steady_clock::now();
+    ostringstream oss;
+    for (const auto& pattern : patterns) oss << pattern << "\n";
+    if (disable) remove(sparseFile.c_str());
+    else writeFile(sparseFile, oss.str());
+    loadSparse();
+
+    loadBranches();
+    head = readFile(headFile);
+    if (!head.empty()) head.erase(head.find_last_not_of(" \n\r\t")+1);
+    unordered_map<string, string> files = loadCommitFiles(branches.count(head) ? branches[head] : "");
+
+    size_t materialized = 0;
+    unsigned long long bytes = 0, totalBytes = 0;
+    for (const auto& pair : files) {
+        struct stat info;
+        string blobPath = objectsDir + "/" + pair.second;
+        if (stat(blobPath.c_str(), &info) == 0) totalBytes += info.st_size;
+        bool present = fileExists(pair.first);
+
+        if (inSparseCone(pair.first)) {
+            if (!present) {
+                createParentDirs(pair.first);
+                writeFile(pair.first, readFile(blobPath));
+            }
+            ++materialized;
+            if (stat(pair.first.c_str(), &info) == 0) bytes += info.st_size;
+        } else if (present) {
+            // Only drop files that match the commit - never lose local edits
+            if (hashToString(simpleHash(readFile(pair.first))) == pair.second) {
+                remove(pair.first.c_str());
+            } else {
+                cout << "Keeping modified file outside the sparse checkout: " << pair.first << "\n";
+            }
+        }
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "Sparse checkout: " << materialized << " of " << files.size() << " files, "
+         << bytes << " of " << totalBytes << " bytes in working tree (" << seconds << "s)\n";
+}
+
+// Print the sparse checkout patterns
+void MiniGit::sparseList() {
+    loadSparse();
+    if (sparsePatterns.empty()) {
+        cout << "Sparse checkout disabled, all files are checked out.\n";
+        return;
+    }
+    for (const auto& pattern : sparsePatterns) cout << pattern << "\n";
+}
+
+// Show which commit introduced each line of a file
+// Walks history from HEAD (through both parents of merges), passing each
+// line to the parent it came from, and stops once every line has an origin.
+// The result is cached per (file, commit), so blaming after new commits
+// only walks back to the last blamed commit
+void MiniGit::blame(const string& file) {
+    loadBranches();
+    head = readFile(headFile);
+    if (!head.empty()) head.erase(head.find_last_not_of(" \n\r\t")+1);
+    string start = branches.count(head) ? branches[head] : "";
+    unordered_map<string, string> files = loadCommitFiles(start);
+    if (!files.count(file)) {
+        cout << "No such file in HEAD: " << file << "\n";
+        return;
+    }
+
+    // Parsed commit headers: parents, date and the blob of this file
+    struct CommitInfo {
+        vector<string> parents;
+        time_t date = 0;
+        string blob;
+    };
+    unordered_map<string, CommitInfo> commits;
+    auto info = [&](const string& hash) -> const CommitInfo& {
+        auto it = commits.find(hash);
+        if (it != commits.end()) return it->second;
+        CommitInfo& ci = commits[hash];
+        istringstream iss(readFile(objectsDir + "/" + hash));
+        string line, prefix = "file " + file + " ";
+        while (getline(iss, line)) {
+            if (line.find("parent ") == 0 && line.size() > 7) ci.parents.push_back(line.substr(7));
+            else if (line.find("parent2 ") == 0 && line.size() > 8) ci.parents.push_back(line.substr(8));
+            else if (line.find("date ") == 0) ci.date = stoll(line.substr(5));
+            else if (line.find(prefix) == 0) ci.blob = line.substr(prefix.size());
+        }
+        return ci;
+    };
+
+    // Cache file: first line is the path, then one origin commit per line
+    auto cachePath = [&](const string& commit) {
+        return blameDir + "/" + hashToString(simpleHash(file)) + "-" + commit;
+    };
+    auto loadCache = [&](const string& commit, vector<string>& origins) {
+        istringstream iss(readFile(cachePath(commit)));
+        string line;
+        if (!getline(iss, line) || line != "path " + file) return false;
+        while (getline(iss, line)) origins.push_back(line);
+        return true;
+    };
+
+    // Line contents by blob, interned for diffing
+    unordered_map<string, int> ids;
+    unordered_map<string, vector<int>> blobLines;
+    auto linesOf = [&](const string& blob) -> const vector<int>& {
+        auto it = blobLines.find(blob);
+        if (it != blobLines.end()) return it->second;
+        return blobLines[blob] = internLines(readFile(objectsDir + "/" + blob), ids);
+    };
+
+    size_t total = linesOf(files[file]).size();
+    vector<string> origins(total);
+    size_t remaining = total;
+
+    // Lines still looking for an origin: commit -> (line in commit, line in HEAD)
+    unordered_map<string, vector<pair<int, int>>> pending;
+    for (size_t i = 0; i < total; ++i) pending[start].push_back({(int)i, (int)i});
+
+    // Newest commits first so a commit's lines are usually all gathered
+    // from its children before it is processed
+    priority_queue<pair<time_t, string>> byDate;
+    byDate.push({info(start).date, start});
+
+    while (remaining > 0 && !byDate.empty()) {
+        string commit = byDate.top().second;
+        byDate.pop();
+        auto pit = pending.find(commit);
+        if (pit == pending.end()) continue; // Already handled
+        vector<pair<int, int>> lines = move(pit->second);
+        pending.erase(pit);
+
+        // A cached result answers every line at once
+        vector<string> cached;
+        if (loadCache(commit, cached)) {
+            for (const auto& l : lines) {
+                if (l.first < (int)cached.size()) origins[l.second] = cached[l.first];
+                else origins[l.second] = commit;
+            }
+            remaining -= lines.size();
+            continue;
+        }
+
+        // Hand lines that already existed in a parent over to it
+        const CommitInfo& ci = info(commit);
+        const vector<int>& mine = linesOf(ci.blob);
+        for (const auto& parent : ci.parents) {
+            if (lines.empty()) break;
+            const CommitInfo& pi = info(parent);
+            if (pi.blob.empty()) continue; // File didn't exist there
+
+            vector<pair<int, int>> passed, kept;
+            if (pi.blob == ci.blob) {
+                passed.swap(lines); // Unchanged - everything came from the parent
+            } else {
+                vector<int> match = matchLines(linesOf(pi.blob), mine);
+                for (const auto& l : lines) {
+                    if (match[l.first] >= 0) passed.push_back({match[l.first], l.second});
+                    else kept.push_back(l);
+                }
+                lines.swap(kept);
+            }
+            if (passed.empty()) continue;
+            vector<pair<int, int>>& target = pending[parent];
+            if (target.empty()) byDate.push({pi.date, parent});
+            target.insert(target.end(), passed.begin(), passed.end());
+        }
+
+        // Whatever no parent had was introduced here
+        for (const auto& l : lines) origins[l.second] = commit;
+        remaining -= lines.size();
+    }
+
+    // Save the result for the next blame
+    createDir(blameDir);
+    ostringstream cache;
+    cache << "path " << file << "\n";
+    for (const auto& origin : origins) cache << origin << "\n";
+    writeFile(cachePath(start), cache.str());
+
+    // Print each line with its origin
+    istringstream content(readFile(objectsDir + "/" + files[file]));
+    string line;
+    for (size_t i = 0; i < total && getline(content, line); ++i) {
+        time_t date = info(origins[i]).date;
+        char when[32];
+        strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", localtime(&date));
+        cout << origins[i].substr(0, 7) << " (" << when << " " << i + 1 << ") " << line << "\n";
+    }
+}